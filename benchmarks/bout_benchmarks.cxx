@@ -0,0 +1,376 @@
+/// Google Benchmark microbenchmarks for BOUT++ core types
+///
+/// Covers Field3D arithmetic, Region iteration, Options lookup, Array
+/// allocation, staggered interpolation, FFT z-shifts, derivative
+/// operators and overlap of guard cell exchange with computation. Field
+/// benchmarks are parameterised by the number of points in each
+/// direction, and run on a mesh created for that size.
+///
+/// Run from this directory, so that data/BOUT.inp is found. Use
+///
+///     ./bout-benchmarks --benchmark_format=json --benchmark_out=results.json
+///
+/// to write JSON which tools/perfdb.py can import. Under MPI every rank
+/// runs every benchmark, but only rank 0 reports. The meshes can be split
+/// between any power of two number of ranks up to 16.
+
+#include <benchmark/benchmark.h>
+
+#include "bout.hxx"
+#include "bout/array.hxx"
+#include "bout/mesh.hxx"
+#include "bout/region.hxx"
+#include "boutcomm.hxx"
+#include "dcomplex.hxx"
+#include "derivs.hxx"
+#include "fft.hxx"
+#include "field3d.hxx"
+#include "fieldgroup.hxx"
+#include "interpolation.hxx"
+#include "options.hxx"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Return a mesh with \p n points in each direction (not counting
+/// guard cells), creating it on first use. Meshes are never freed, as
+/// they must outlive every field created on them.
+Mesh* benchmarkMesh(int n) {
+  static std::map<int, Mesh*> meshes;
+  auto& mesh = meshes[n];
+  if (mesh == nullptr) {
+    auto& options = Options::root()["benchmark_mesh_" + std::to_string(n)];
+    options["nx"] = n + 4;
+    options["ny"] = n;
+    options["nz"] = n;
+    options["staggergrids"] = true;
+    mesh = Mesh::create(&options);
+    mesh->load();
+  }
+  return mesh;
+}
+
+/// A smoothly varying field on \p mesh, including guard cells
+Field3D benchmarkField(Mesh* mesh, BoutReal phase = 0.0) {
+  Field3D f{mesh};
+  f.allocate();
+  BOUT_FOR(i, f.getRegion("RGN_ALL")) { f[i] = 1.0 + 0.1 * std::sin(0.01 * i.ind + phase); }
+  return f;
+}
+
+void setFieldCounters(benchmark::State& state, const Mesh* mesh) {
+  state.SetItemsProcessed(state.iterations() * mesh->LocalNx * mesh->LocalNy
+                          * mesh->LocalNz);
+}
+
+void BM_Field3DArithmetic(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto a = benchmarkField(mesh, 0.0);
+  const auto b = benchmarkField(mesh, 1.0);
+  const auto c = benchmarkField(mesh, 2.0);
+  for (auto _ : state) {
+    Field3D result = a * b + c;
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_Field3DArithmetic)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_RegionIteration(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto a = benchmarkField(mesh, 0.0);
+  const auto b = benchmarkField(mesh, 1.0);
+  auto result = benchmarkField(mesh);
+  for (auto _ : state) {
+    BOUT_FOR(i, result.getRegion("RGN_NOBNDRY")) { result[i] = a[i] * b[i]; }
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_RegionIteration)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_RegionIterationSerial(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto a = benchmarkField(mesh, 0.0);
+  const auto b = benchmarkField(mesh, 1.0);
+  auto result = benchmarkField(mesh);
+  for (auto _ : state) {
+    BOUT_FOR_SERIAL(i, result.getRegion("RGN_NOBNDRY")) { result[i] = a[i] * b[i]; }
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_RegionIterationSerial)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_OptionsLookup(benchmark::State& state) {
+  const int nkeys = state.range(0);
+  Options options;
+  std::vector<std::string> keys;
+  for (int k = 0; k < nkeys; ++k) {
+    keys.push_back("key" + std::to_string(k));
+    options["section"][keys.back()] = static_cast<BoutReal>(k);
+  }
+  for (auto _ : state) {
+    BoutReal sum = 0.0;
+    for (const auto& key : keys) {
+      sum += options["section"][key].as<BoutReal>();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * nkeys);
+}
+BENCHMARK(BM_OptionsLookup)->RangeMultiplier(8)->Range(8, 512);
+
+void BM_ArrayAllocation(benchmark::State& state) {
+  const int size = state.range(0);
+  for (auto _ : state) {
+    Array<BoutReal> array(size);
+    benchmark::DoNotOptimize(array.begin());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ArrayAllocation)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+void BM_InterpToXLow(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = interp_to(f, CELL_XLOW);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_InterpToXLow)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_InterpToYLow(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = interp_to(f, CELL_YLOW);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_InterpToYLow)->RangeMultiplier(2)->Range(16, 64);
+
+/// Shift every z-line of a field by a constant angle in Fourier space,
+/// as ShiftedMetric does for each toroidal shift
+void BM_FFTShift(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  auto f = benchmarkField(mesh);
+  const int nz = mesh->LocalNz;
+  const int nmodes = nz / 2 + 1;
+
+  Array<dcomplex> phases(nmodes);
+  for (int k = 0; k < nmodes; ++k) {
+    phases[k] = dcomplex(std::cos(0.1 * k), -std::sin(0.1 * k));
+  }
+  Array<dcomplex> modes(nmodes);
+
+  for (auto _ : state) {
+    for (int x = 0; x < mesh->LocalNx; ++x) {
+      for (int y = 0; y < mesh->LocalNy; ++y) {
+        bout::fft::rfft(&f(x, y, 0), nz, modes.begin());
+        for (int k = 0; k < nmodes; ++k) {
+          modes[k] *= phases[k];
+        }
+        bout::fft::irfft(modes.begin(), nz, &f(x, y, 0));
+      }
+    }
+    benchmark::DoNotOptimize(f);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_FFTShift)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_DDX(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = DDX(f);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_DDX)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_DDY(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = DDY(f);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_DDY)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_DDZ(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = DDZ(f);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_DDZ)->RangeMultiplier(2)->Range(16, 64);
+
+void BM_D2DX2(benchmark::State& state) {
+  auto* mesh = benchmarkMesh(state.range(0));
+  const auto f = benchmarkField(mesh);
+  for (auto _ : state) {
+    Field3D result = D2DX2(f);
+    benchmark::DoNotOptimize(result);
+  }
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_D2DX2)->RangeMultiplier(2)->Range(16, 64);
+
+/// Split-phase guard cell exchange of \p f, as in an RHS which sends its
+/// guard cells and then computes the interior while they are in flight
+class Exchange {
+public:
+  Exchange(Mesh* mesh, Field3D& f) : mesh(mesh), group(f) {}
+  void send() { handle = mesh->send(group); }
+  void wait() { mesh->wait(handle); }
+
+private:
+  Mesh* mesh;
+  FieldGroup group;
+  comm_handle handle{nullptr};
+};
+
+/// Overlap of a guard cell exchange with computation on the interior.
+///
+/// The "overlap" counter is the fraction of the shorter of the exchange
+/// and the computation which is hidden when they run together: 1 is
+/// complete overlap, 0 none. Messages only progress while a rank is
+/// inside MPI unless the MPI library has a progress thread, e.g. with
+/// BOUT_MPI_ASYNC_PROGRESS=1 in perlmutter/setup-perlmutter.sh. When the
+/// second argument is 1 the computation instead calls MPI_Iprobe after
+/// each pass, to drive progress by polling.
+///
+/// Only meaningful with several ranks (BOUT_MPIRUN in run-benchmarks.sh).
+/// The iteration count is fixed so that all ranks communicate equally.
+void BM_CommOverlap(benchmark::State& state) {
+  using clock = std::chrono::steady_clock;
+  auto* mesh = benchmarkMesh(state.range(0));
+  const bool poll = state.range(1) != 0;
+  const auto a = benchmarkField(mesh, 0.0);
+  const auto b = benchmarkField(mesh, 1.0);
+  auto result = benchmarkField(mesh);
+  auto f = benchmarkField(mesh, 2.0);
+  Exchange exchange(mesh, f);
+
+  const auto compute = [&]() {
+    constexpr int passes = 8;
+    for (int pass = 0; pass < passes; ++pass) {
+      BOUT_FOR(i, result.getRegion("RGN_NOBNDRY")) { result[i] = a[i] * b[i] + result[i]; }
+      if (poll) {
+        int flag;
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, BoutComm::get(), &flag, MPI_STATUS_IGNORE);
+      }
+    }
+    benchmark::DoNotOptimize(result);
+  };
+  // Fastest of several runs of step, in seconds
+  const auto fastest = [](auto step) {
+    double best = 1e30;
+    for (int run = 0; run < 10; ++run) {
+      MPI_Barrier(BoutComm::get());
+      const auto start = clock::now();
+      step();
+      best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+    }
+    return best;
+  };
+
+  const double comm_time = fastest([&]() {
+    exchange.send();
+    exchange.wait();
+  });
+  const double compute_time = fastest(compute);
+
+  double overlapped_time = 1e30;
+  for (auto _ : state) {
+    state.PauseTiming();
+    MPI_Barrier(BoutComm::get());
+    state.ResumeTiming();
+    const auto start = clock::now();
+    exchange.send();
+    compute();
+    exchange.wait();
+    overlapped_time = std::min(
+        overlapped_time, std::chrono::duration<double>(clock::now() - start).count());
+  }
+
+  state.counters["comm_s"] = comm_time;
+  state.counters["compute_s"] = compute_time;
+  state.counters["overlap"] =
+      (comm_time + compute_time - overlapped_time) / std::min(comm_time, compute_time);
+  setFieldCounters(state, mesh);
+}
+BENCHMARK(BM_CommOverlap)
+    ->ArgsProduct({{16, 32, 64}, {0, 1}})
+    ->ArgNames({"n", "poll"})
+    ->Iterations(100);
+
+/// Discards all results, for ranks other than 0
+class NullReporter : public benchmark::BenchmarkReporter {
+public:
+  bool ReportContext(const Context&) override { return true; }
+  void ReportRuns(const std::vector<Run>&) override {}
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  // MPI is initialised before BOUT++, so that ranks other than 0 can drop
+  // --benchmark_out before Google Benchmark opens (and truncates) the file
+  MPI_Init(&argc, &argv);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    if (rank == 0 || std::strncmp(argv[i], "--benchmark_out", 15) != 0) {
+      args.push_back(argv[i]);
+    }
+  }
+  int nargs = args.size();
+  args.push_back(nullptr);
+  char** bout_argv = args.data();
+
+  // Google Benchmark removes its own arguments, leaving those for BOUT++
+  benchmark::Initialize(&nargs, bout_argv);
+
+  if (BoutInitialise(nargs, bout_argv) != 0) {
+    BoutFinalise();
+    return 1;
+  }
+
+  if (rank == 0) {
+    benchmark::RunSpecifiedBenchmarks();
+  } else {
+    NullReporter null_reporter;
+    benchmark::RunSpecifiedBenchmarks(&null_reporter);
+  }
+
+  BoutFinalise();
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (finalized == 0) {
+    MPI_Finalize();
+  }
+  return 0;
+}
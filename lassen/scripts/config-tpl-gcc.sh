@@ -60,4 +60,25 @@ elif [ "$pkg" == "umpire" ]; then
           -DCMAKE_EXPORT_COMPILE_COMMANDS=On \
           -DCMAKE_VERBOSE_MAKEFILE=On \
           $source_dir
+elif [ "$pkg" == "benchmark" ]; then
+    source_dir=${source_prefix}/benchmark
+    mkdir -p $build_dir && cd $build_dir
+    cmake -DCMAKE_CXX_COMPILER=$cpp \
+          -DCMAKE_C_COMPILER=$cc \
+          -DCMAKE_INSTALL_PREFIX=$install_dir \
+          -DCMAKE_BUILD_TYPE=Release \
+          -DBENCHMARK_ENABLE_TESTING=Off \
+          -DBENCHMARK_ENABLE_GTEST_TESTS=Off \
+          -DCMAKE_EXPORT_COMPILE_COMMANDS=On \
+          -DCMAKE_VERBOSE_MAKEFILE=On \
+          $source_dir
+elif [ "$pkg" == "xbraid" ]; then
+    # XBraid has no out-of-source build, so build from a copy of the source
+    source_dir=${source_prefix}/xbraid
+    mkdir -p $build_dir && cd $build_dir
+    cp -r ${source_dir}/. $build_dir
+    make braid debug=no MPICC=$cc MPICXX=$cpp
+    mkdir -p ${install_dir}/include ${install_dir}/lib
+    cp braid/*.h braid/*.hpp ${install_dir}/include
+    cp braid/libbraid.a ${install_dir}/lib
 fi
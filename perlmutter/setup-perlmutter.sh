@@ -64,6 +64,15 @@ module load netcdf-c-4.8.1-gcc-9.3.0-yx3q7wo
 module load netcdf-cxx4-4.3.1-gcc-9.3.0-howgwk7
 module load superlu-dist-6.4.0-gcc-9.3.0-qgrx3gd
 
+# Set BOUT_MPI_ASYNC_PROGRESS=1 before sourcing to start a Cray MPICH
+# progress thread per rank, so that non-blocking guard cell exchanges
+# progress while BOUT++ is computing. The thread needs a core of its own.
+if [[ "$BOUT_MPI_ASYNC_PROGRESS" == 1 ]]
+then
+    export MPICH_MAX_THREAD_SAFETY=multiple
+    export MPICH_ASYNC_PROGRESS=1
+fi
+
 alias sxd='salloc -C gpu -N 1 -t 60 -A mp2_g'
 
 module list
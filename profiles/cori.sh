@@ -0,0 +1,66 @@
+# Machine profile for NERSC Cori GPU (cgpu) nodes
+#
+# Read by tools/bout-profile.sh, which generates the cmake invocation and
+# a BOUT.inp performance fragment from it. Use with the environment from
+# cori/setup-env-cgpu.sh.
+
+setup_script=cori/setup-env-cgpu.sh
+
+# Node: 2x Intel Xeon Gold 6148 (Skylake), 8x NVIDIA V100, 384 GB
+cpu_arch=skylake-avx512
+simd_width=512                   # bits (AVX-512)
+numa_domains=2
+cores_per_numa=20
+memory_gb=384
+gpus=8
+cuda_arch="compute_70,code=sm_70"
+
+# Build
+tpl_prefix=/global/project/projectdirs/bout/BOUT-GPU/tpl_11h/
+module_prefix=/global/project/projectdirs/bout/BOUT-GPU/spack/opt/spack/cray-cnl7-skylake_avx512/gcc-8.3.0_cgpu/
+cc=mpicc
+cxx=mpiCC
+cxx_standard=14
+arch_flags="-march=skylake-avx512"
+cxx_flags="-w -O3"
+cuda_flags="-w"
+region_block_size=64             # MAXREGIONBLOCKSIZE; BOUT++ default until autotuned
+# Run-time library paths for the spack TPLs, so binaries run without the
+# module environment
+rpath="${module_prefix}/petsc-3.13.0-ym7gwgxfutg4m7ap3bz5tbvsitvfq2w2/lib;${module_prefix}/hdf5-1.10.6-twbl2egvtk5bmvx4bmlvpnugciapg46s/lib;${module_prefix}/netcdf-cxx4-4.3.1-ptxvbr5iimq3lcapnzs5tw7heniv7mha/lib;${module_prefix}/netcdf-c-4.7.4-hpuuuxa5vze5qwvqhdzxlpkrigjghgtu/lib;${module_prefix}/fftw-3.3.8-3nkroqhdwtudny5aifsjujxmzdvdz3jw/lib;${module_prefix}/sundials-5.1.0-nxrldjqsuekh3nmm4soadzjlwy3ggwz4/lib64"
+cmake_options=(
+    -DCMAKE_PREFIX_PATH="${tpl_prefix}/install/x86_64-gcc/raja/share/raja/cmake;${tpl_prefix}/install/x86_64-gcc/umpire/share/umpire/cmake"
+    -DNCXX4_CONFIG:FILEPATH=${module_prefix}/netcdf-cxx4-4.3.1-ptxvbr5iimq3lcapnzs5tw7heniv7mha/bin/ncxx4-config
+    -DNC_CONFIG:FILEPATH=${module_prefix}/netcdf-c-4.7.4-hpuuuxa5vze5qwvqhdzxlpkrigjghgtu/bin/nc-config
+    -DnetCDF_ROOT=${module_prefix}/netcdf-c-4.7.4-hpuuuxa5vze5qwvqhdzxlpkrigjghgtu/
+    -DBOUT_USE_NETCDF=On
+    -DBOUT_USE_FFTW=On
+    -DFFTW_ROOT=${module_prefix}/fftw-3.3.8-3nkroqhdwtudny5aifsjujxmzdvdz3jw/
+    -DBOUT_USE_LAPACK=On
+    -DBOUT_USE_NLS=On
+    -DBOUT_USE_PETSC=On
+    -DPETSC_DIR=${module_prefix}/petsc-3.13.0-ym7gwgxfutg4m7ap3bz5tbvsitvfq2w2
+    -DBOUT_USE_PVODE=On
+    -DBOUT_USE_SUNDIALS=On
+    -DBOUT_ENABLE_RAJA=On
+    -DBOUT_ENABLE_UMPIRE=On
+    -DBOUT_ENABLE_MPI=On
+    -DBOUT_ENABLE_OPENMP=Off
+    -DBOUT_ENABLE_WARNINGS=Off
+    -DBOUT_ENABLE_CUDA=On
+    -DCMAKE_CUDA_STANDARD=14
+    -DBOUT_USE_HYPRE=On
+    -DHYPRE_ROOT=${tpl_prefix}/hypre_dir/hypre_autoconf/install
+    -DHYPRE_CUDA=On
+    -DBUILD_SHARED_LIBS=Off
+    -DCHECK=1
+    -DCMAKE_INSTALL_RPATH="${rpath}"
+    -DCMAKE_BUILD_RPATH="${rpath}"
+)
+
+# Run time: one rank per GPU, four to each socket
+ranks_per_node=8
+omp_threads=1
+solver_type=cvode
+laplace_type=hypre3d
+io_backend=netcdf
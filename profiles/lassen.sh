@@ -0,0 +1,62 @@
+# Machine profile for LLNL Lassen
+#
+# Read by tools/bout-profile.sh, which generates the cmake invocation and
+# a BOUT.inp performance fragment from it. Use with the environment from
+# lassen/scripts/setup-lassen-gpu.sh.
+
+setup_script=lassen/scripts/setup-lassen-gpu.sh
+
+# Node: 2x IBM POWER9 (20 usable cores each), 4x NVIDIA V100, 256 GB
+cpu_arch=power9
+simd_width=128                   # bits (VSX)
+numa_domains=2
+cores_per_numa=20
+memory_gb=256
+gpus=4
+cuda_arch=sm_70
+
+# Build
+env_prefix=/usr/WS2/BOUT-GPU/lassen/env/
+module_prefix=${env_prefix}/spack/opt/spack/linux-rhel7-power9le/gcc-8.3.1/
+cc=mpicc
+cxx=mpiCC
+cxx_standard=14
+arch_flags="-mcpu=power9 -mtune=power9"
+cxx_flags="-w -O3"
+cuda_flags="-w"
+region_block_size=64             # MAXREGIONBLOCKSIZE; BOUT++ default until autotuned
+# Run-time library paths for the spack TPLs, so binaries run without the
+# module environment
+rpath="${module_prefix}/petsc-3.13.0-7b3be6747en6tm2v4ifa4zri556pdcxl/lib;${module_prefix}/hdf5-1.10.6-zkwocrtngfhf5nw6xk5c4cbekrdycznu/lib"
+cmake_options=(
+    -DCMAKE_PREFIX_PATH="${env_prefix}/tpl/install/ppc64le-gcc/raja/share/raja/cmake;${env_prefix}/tpl/install/ppc64le-gcc/umpire/share/umpire/cmake"
+    -DNCXX4_CONFIG:FILEPATH=${module_prefix}/netcdf-cxx4-4.3.1-sj65c6a4kyaaw3d6dopj6txamfkli3dc/bin/ncxx4-config
+    -DNC_CONFIG:FILEPATH=${module_prefix}/netcdf-c-4.7.4-7x3quj36clrfnejvxqyb5ky6gbco73zr/bin/nc-config
+    -DUSE_NETCDF=On
+    -DUSE_FFTW=On
+    -DUSE_LAPACK=On
+    -DUSE_NLS=On
+    -DENABLE_PETSC=On
+    -DPETSC_DIR=${module_prefix}/petsc-3.13.0-7b3be6747en6tm2v4ifa4zri556pdcxl
+    -DENABLE_HYPRE=On
+    -DHYPRE_DIR=${env_prefix}/tpl/hypre_automake/install
+    -DHYPRE_CUDA=On
+    -DUSE_PVODE=On
+    -DUSE_SUNDIALS=On
+    -DENABLE_RAJA=On
+    -DENABLE_UMPIRE=Off
+    -DENABLE_MPI=On
+    -DENABLE_OPENMP=Off
+    -DENABLE_CUDA=On
+    -DCMAKE_CUDA_STANDARD=14
+    -DBUILD_SHARED_LIBS=Off
+    -DCMAKE_INSTALL_RPATH="${rpath}"
+    -DCMAKE_BUILD_RPATH="${rpath}"
+)
+
+# Run time: one rank per GPU, two to each socket
+ranks_per_node=4
+omp_threads=1
+solver_type=cvode
+laplace_type=hypre3d
+io_backend=netcdf
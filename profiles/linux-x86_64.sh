@@ -0,0 +1,43 @@
+# Machine profile for a plain Linux x86_64 workstation
+#
+# Read by tools/bout-profile.sh, which generates the cmake invocation and
+# a BOUT.inp performance fragment from it. Assumes MPI, NetCDF and FFTW
+# from the system package manager, and no GPU.
+
+setup_script=
+
+# Node: a single socket, all cores in one NUMA domain
+cpu_arch=native
+simd_width=256                   # bits; assumes AVX2
+numa_domains=1
+cores_per_numa=$(nproc)
+memory_gb=$(awk '/MemTotal/ {print int($2 / 1048576)}' /proc/meminfo)
+gpus=0
+cuda_arch=
+
+# Build
+cc=mpicc
+cxx=mpicxx
+cxx_standard=17
+arch_flags="-march=native"
+cxx_flags="-w -O3"
+cuda_flags=
+region_block_size=64             # MAXREGIONBLOCKSIZE; BOUT++ default until autotuned
+cmake_options=(
+    -DBOUT_USE_NETCDF=On
+    -DBOUT_USE_FFTW=On
+    -DBOUT_USE_LAPACK=On
+    -DBOUT_USE_PETSC=Off
+    -DBOUT_USE_PVODE=On
+    -DBOUT_USE_SUNDIALS=Off
+    -DBOUT_ENABLE_MPI=On
+    -DBOUT_ENABLE_OPENMP=Off
+    -DBUILD_SHARED_LIBS=On
+)
+
+# Run time: one rank per core
+ranks_per_node=$(nproc)
+omp_threads=1
+solver_type=pvode
+laplace_type=cyclic
+io_backend=netcdf
@@ -0,0 +1,55 @@
+# Machine profile for NERSC Perlmutter GPU nodes
+#
+# Read by tools/bout-profile.sh, which generates the cmake invocation and
+# a BOUT.inp performance fragment from it. Use with the environment from
+# perlmutter/setup-perlmutter.sh.
+
+setup_script=perlmutter/setup-perlmutter.sh
+
+# Node: 1x AMD EPYC 7763 (Milan) in NPS4 mode, 4x NVIDIA A100, 256 GB
+cpu_arch=znver2                  # gcc 9.3 has no znver3; matches craype-x86-rome
+simd_width=256                   # bits (AVX2)
+numa_domains=4
+cores_per_numa=16
+memory_gb=256
+gpus=4
+cuda_arch="compute_80,code=sm_80"
+
+# Build
+tpl_prefix=/global/cfs/cdirs/bout/BOUT-GPU/tpl_11p/
+cc=mpicc
+cxx=mpicxx
+cxx_standard=17
+arch_flags="-march=znver2"
+cxx_flags="-w -O3"
+cuda_flags="-w"
+region_block_size=64             # MAXREGIONBLOCKSIZE; BOUT++ default until autotuned
+cmake_options=(
+    -DBOUT_USE_NETCDF=On
+    -DBOUT_USE_FFTW=On
+    -DBOUT_USE_LAPACK=On
+    -DBOUT_USE_NLS=On
+    -DBOUT_USE_PETSC=On
+    -DPETSC_DIR=${tpl_prefix}/petsc/
+    -DPETSC_ARCH=arch-linux-c-debug
+    -DBOUT_USE_PVODE=On
+    -DBOUT_USE_SUNDIALS=On
+    -DBOUT_ENABLE_RAJA=On
+    -DBOUT_ENABLE_UMPIRE=On
+    -DBOUT_ENABLE_MPI=On
+    -DBOUT_ENABLE_OPENMP=Off
+    -DBOUT_ENABLE_CUDA=On
+    -DCMAKE_CUDA_STANDARD=17
+    -DBOUT_USE_HYPRE=On
+    -DHYPRE_DIR=${tpl_prefix}/petsc/install/x86_64-gcc
+    -DHYPRE_CUDA=Off
+    -DBUILD_SHARED_LIBS=Off
+    -DCHECK=1
+)
+
+# Run time: one rank per GPU, each bound to its own NUMA domain
+ranks_per_node=4
+omp_threads=1
+solver_type=cvode
+laplace_type=petsc
+io_backend=netcdf
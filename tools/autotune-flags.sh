@@ -0,0 +1,260 @@
+#!/usr/bin/env bash
+# Tune the C++ compiler flags and region block size for BOUT++ on the
+# current machine.
+#
+# Candidate settings are built from one choice per axis (optimisation
+# level, target architecture, loop unrolling, vectoriser cost model, a
+# safe subset of fast-math, and MAXREGIONBLOCKSIZE). Each axis is swept
+# in turn, keeping the best choice so far, which needs far fewer rebuilds
+# than trying every combination. For each candidate BOUT-dev is rebuilt
+# in build_dir, the correctness subset is run, and the benchmarks from
+# run-benchmarks.sh are timed. Candidates which fail to build or fail the
+# checks are discarded. A candidate only replaces the best so far if its
+# total time is lower by at least the minimum gain and significantly
+# lower under a one-sided Welch t-test (p < 0.05) over the repeats, so
+# noise does not end up in the profile.
+#
+# The compiler family (gcc, clang or xl) is found from the profile's cxx.
+# The architecture axis starts from the profile's arch_flags and the
+# block size axis from its region_block_size. The winners are written
+# back to the profile as arch_flags, region_block_size and, for the
+# remaining flags, cxx_flags, which is how bout-profile.sh combines them.
+# A native architecture is resolved to the concrete CPU, which is also
+# written as cpu_arch, so the profile does not depend on the host that
+# uses it. build_dir is left configured with the winning settings.
+#
+# usage: autotune-flags.sh [-n repeats] [-g gain] -p profile build_dir
+#   -n  repeats of each benchmark per candidate (default 3)
+#   -g  minimum relative gain to accept a new choice (default 0.03)
+#   -p  machine profile to update, e.g. perlmutter or profiles/perlmutter.sh
+#
+# build_dir must already be configured, e.g. by the config-bout script
+# for this machine, and the profile's compiler must be in the PATH.
+tools_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+profiles_dir=$(cd "${tools_dir}/../profiles" && pwd)
+
+repeats=3
+min_gain=0.03
+profile=
+while getopts "n:g:p:" opt; do
+    case $opt in
+        n) repeats=$OPTARG ;;
+        g) min_gain=$OPTARG ;;
+        p) profile=$OPTARG ;;
+        *) exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [[ $# -ne 1 || -z "$profile" ]]; then
+    echo "usage: $0 [-n repeats] [-g gain] -p profile build_dir" >&2
+    exit 1
+fi
+if [[ $repeats -lt 2 ]]; then
+    echo "At least 2 repeats are needed to compare candidates" >&2
+    exit 1
+fi
+build_dir=$(cd "$1" && pwd) || exit 1
+[[ -f "$profile" ]] || profile=${profiles_dir}/${profile}.sh
+if [[ ! -f "$profile" ]]; then
+    echo "No profile $profile" >&2
+    exit 1
+fi
+cxx=$(source $profile && echo $cxx)
+profile_arch_flags=$(source $profile && echo $arch_flags)
+region_block_size=$(source $profile && echo $region_block_size)
+
+version=$($cxx --version 2> /dev/null | head -1)
+case "$version" in
+    *"IBM XL"*|*xlC*) compiler=xl ;;
+    *clang*) compiler=clang ;;
+    *GCC*|*g++*) compiler=gcc ;;
+    *)
+        echo "Cannot tell the compiler family of $cxx from $profile" >&2
+        exit 1 ;;
+esac
+echo "Tuning for $compiler ($cxx)" >&2
+
+if [[ "$compiler" == "xl" ]]; then
+    native="-qarch=auto -qtune=auto"
+elif [[ "$(uname -m)" == "ppc64le" ]]; then
+    native="-mcpu=native"
+else
+    native="-march=native"
+fi
+
+# Each axis is a ';' separated list of choices, the first being the
+# starting point. The second axis is the target architecture and the
+# last is the region block size. Only value-safe fast-math options are
+# offered: BOUT++ relies on NaN and infinity checks, so
+# -ffinite-math-only and -ffast-math are never tried.
+arch_axis="${profile_arch_flags}"
+[[ "$profile_arch_flags" != "$native" ]] && arch_axis+=";${native}"
+if [[ "$compiler" == "gcc" ]]; then
+    axes=("-O2;-O3"
+          "${arch_axis}"
+          ";-funroll-loops"
+          ";-fvect-cost-model=dynamic;-fvect-cost-model=unlimited"
+          ";-fno-math-errno;-fno-math-errno -fno-trapping-math")
+elif [[ "$compiler" == "clang" ]]; then
+    axes=("-O2;-O3"
+          "${arch_axis}"
+          ";-funroll-loops"
+          ";-fno-slp-vectorize"
+          ";-fno-math-errno;-fno-math-errno -fno-trapping-math")
+else
+    axes=("-O2;-O3 -qstrict"
+          "${arch_axis}"
+          ";-qunroll=yes"
+          ";-qsimd=auto")
+fi
+block_axis=${region_block_size:-64}
+for size in 16 32 64 128 256; do
+    [[ $size -ne ${region_block_size:-64} ]] && block_axis+=";$size"
+done
+axes+=("$block_axis")
+block=$((${#axes[@]} - 1))
+
+# Rebuild BOUT++ in build_dir with the given flags, architecture flags
+# and MAXREGIONBLOCKSIZE, combined as in bout-profile.sh. The
+# optimisation level comes from the flags, so the Release defaults are
+# overridden.
+rebuild() {
+    cmake -DCMAKE_BUILD_TYPE=Release \
+          -DCMAKE_CXX_FLAGS_RELEASE="-DNDEBUG" \
+          -DCMAKE_CXX_FLAGS="$(echo $1 $2) -DMAXREGIONBLOCKSIZE=$3" \
+          $build_dir > /dev/null || return
+    cmake --build $build_dir --parallel ${BOUT_BUILD_JOBS:-$(nproc)} > /dev/null
+}
+
+# Build, check and benchmark a candidate, printing the total benchmark
+# time of each repeat, or nothing if the candidate is rejected. A
+# candidate is only accepted if every benchmark ran all its repeats.
+measure() {
+    local output
+    rebuild "$1" "$2" "$3" || return
+    output=$(${tools_dir}/run-benchmarks.sh -t -n $repeats $build_dir) || return
+    echo "$output" | awk -v n=$repeats -v expected="$(${tools_dir}/run-benchmarks.sh -l)" '
+        {count[$1]++; total[count[$1]] += $2}
+        END {
+            nb = split(expected, names, " ")
+            if (NR != n * nb) exit
+            for (i = 1; i <= nb; i++) if (count[names[i]] != n) exit
+            for (r = 1; r <= n; r++) printf "%.6f%s", total[r], r < n ? " " : ""
+        }'
+}
+
+mean() {
+    echo $1 | awk '{for (i = 1; i <= NF; i++) s += $i; printf "%.6f", s / NF}'
+}
+
+# Succeed if the samples $1 are faster than $2 by at least min_gain and
+# significantly so, using the Welch test from perfdb.py
+faster() {
+    python3 -B - "$1" "$2" $min_gain <<EOF
+import sys
+sys.path.insert(0, "${tools_dir}")
+from perfdb import mean_var, welch_slower
+new = [float(x) for x in sys.argv[1].split()]
+best = [float(x) for x in sys.argv[2].split()]
+gain = 1.0 - mean_var(new)[0] / mean_var(best)[0]
+sys.exit(0 if gain >= float(sys.argv[3]) and welch_slower(new, best) < 0.05 else 1)
+EOF
+}
+
+declare -A timings
+choice=()
+for ((a = 0; a < ${#axes[@]}; a++)); do
+    IFS=';' read -ra values <<< "${axes[$a]}"
+    choice[$a]=${values[0]}
+done
+
+# Compiler flags of the current choices, without the architecture and
+# block size axes
+cxx_flags_of() {
+    local rest=("${choice[@]}")
+    unset 'rest[1]' "rest[$block]"
+    echo -w ${rest[*]}
+}
+
+best_flags=
+best_arch=
+best_block=
+best_samples=
+for ((a = 0; a < ${#axes[@]}; a++)); do
+    IFS=';' read -ra values <<< "${axes[$a]}"
+    [[ ${#values[@]} -eq 0 ]] && values=("")
+    best_value=${choice[$a]}
+    for value in "${values[@]}"; do
+        choice[$a]=$value
+        flags=$(cxx_flags_of)
+        arch=$(echo ${choice[1]})
+        size=${choice[$block]}
+        key="$flags $arch $size"
+        if [[ -z "${timings[$key]+set}" ]]; then
+            echo "Trying '$flags' '$arch' block $size" >&2
+            timings[$key]=$(measure "$flags" "$arch" "$size")
+            if [[ -n "${timings[$key]}" ]]; then
+                echo "    $(mean "${timings[$key]}") s" >&2
+            else
+                echo "    rejected" >&2
+            fi
+        fi
+        samples=${timings[$key]}
+        [[ -z "$samples" || "$key" == "$best_flags $best_arch $best_block" ]] && continue
+        if [[ -z "$best_samples" ]] || faster "$samples" "$best_samples"; then
+            best_samples=$samples
+            best_flags=$flags
+            best_arch=$arch
+            best_block=$size
+            best_value=$value
+        fi
+    done
+    choice[$a]=$best_value
+done
+
+if [[ -z "$best_samples" ]]; then
+    echo "No candidate flags passed the checks" >&2
+    exit 1
+fi
+
+echo "Best flags: '$best_flags', arch '$best_arch', block size $best_block" \
+     "($(mean "$best_samples") s)"
+
+# Resolve a native architecture to the CPU the compiler picks for it
+cpu=
+if [[ "$best_arch" == "$native" ]]; then
+    if [[ "$compiler" == "gcc" ]]; then
+        cpu=$($cxx $native -Q --help=target 2> /dev/null \
+                  | awk -v opt="${native%%=*}=" '$1 == opt {print $2; exit}')
+        [[ -n "$cpu" ]] && best_arch="${native%%=*}=$cpu"
+    elif [[ "$compiler" == "clang" ]]; then
+        cpu=$($cxx $native -### -c -x c++ /dev/null 2>&1 \
+                  | grep -o '"-target-cpu" "[^"]*"' | cut -d'"' -f4)
+        [[ -n "$cpu" ]] && best_arch="${native%%=*}=$cpu"
+    else
+        cpu=$(awk -F: '/^cpu/ {print tolower($2); exit}' /proc/cpuinfo | tr -cd 'a-z0-9')
+        [[ -n "$cpu" ]] && best_arch="-qarch=${cpu/power/pwr} -qtune=${cpu/power/pwr}"
+    fi
+    if [[ -z "$cpu" ]]; then
+        echo "Cannot resolve '$native' to a CPU; $profile not updated" >&2
+        exit 1
+    fi
+    echo "Resolved '$native' to '$best_arch'"
+fi
+rebuild "$best_flags" "$best_arch" "$best_block" || exit 1
+
+# Replace a setting in the profile, or add it if missing
+set_profile() {
+    local line="$1=\"$2\"  # autotuned on $(hostname) $(date +%F)"
+    if grep -q "^$1=" "$profile"; then
+        sed -i "s|^$1=.*|$line|" "$profile"
+    else
+        echo "$line" >> "$profile"
+    fi
+}
+[[ -n "$cpu" ]] && set_profile cpu_arch "$cpu"
+set_profile arch_flags "$best_arch"
+set_profile cxx_flags "$best_flags"
+set_profile region_block_size "$best_block"
+echo "Updated $profile"
@@ -0,0 +1,138 @@
+#!/usr/bin/env bash
+# Generate build and run settings for BOUT++ from a machine profile.
+#
+# usage: bout-profile.sh [-p profile] list
+#        bout-profile.sh [-p profile] show
+#        bout-profile.sh [-p profile] [-r] cmake [source_dir [build_dir]] [-- cmake args]
+#        bout-profile.sh [-p profile] inp
+#
+#   list   list the available profiles
+#   show   print the profile settings
+#   cmake  print the cmake invocation for the profile, or run it with -r.
+#          source_dir defaults to the current directory, build_dir to
+#          build/<arch>-<profile> under it. This sits alongside the
+#          config-bout scripts' build/<arch>-<compiler>/BOUT-dev, so the
+#          two builds do not overwrite each other.
+#          Arguments after -- are appended to the cmake command.
+#   inp    print a BOUT.inp fragment with the tuned run-time settings
+#
+# The profile is a name in the profiles directory or a path to a profile
+# file. If not given, it is chosen from NERSC_HOST or LCSCHEDCLUSTER,
+# falling back to linux-<arch>.
+profiles_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")/../profiles" && pwd)
+
+profile=
+run=0
+while getopts "p:r" opt; do
+    case $opt in
+        p) profile=$OPTARG ;;
+        r) run=1 ;;
+        *) exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+mode=$1
+shift
+
+if [[ "$mode" == "list" ]]; then
+    for f in ${profiles_dir}/*.sh; do
+        basename $f .sh
+    done
+    exit 0
+fi
+
+if [[ -z "$profile" ]]; then
+    profile=${NERSC_HOST:-${LCSCHEDCLUSTER:-linux-$(uname -m)}}
+fi
+if [[ -f "$profile" ]]; then
+    profile_file=$profile
+else
+    profile_file=${profiles_dir}/${profile}.sh
+fi
+if [[ ! -f "$profile_file" ]]; then
+    echo "No profile $profile in ${profiles_dir}" >&2
+    exit 1
+fi
+profile_name=$(basename $profile_file .sh)
+source $profile_file
+
+if [[ "$mode" == "show" ]]; then
+    echo "profile:         $profile_name ($profile_file)"
+    echo "cpu_arch:        $cpu_arch"
+    echo "simd_width:      $simd_width"
+    echo "numa:            $numa_domains x $cores_per_numa cores"
+    echo "memory_gb:       $memory_gb"
+    echo "gpus:            $gpus ${cuda_arch}"
+    echo "compilers:       $cc $cxx (C++$cxx_standard)"
+    echo "cxx_flags:       $cxx_flags $arch_flags"
+    echo "region_block:    $region_block_size"
+    echo "ranks_per_node:  $ranks_per_node x $omp_threads threads"
+    echo "solver:          $solver_type"
+    echo "laplace:         $laplace_type"
+    echo "io:              $io_backend"
+elif [[ "$mode" == "cmake" ]]; then
+    source_dir=$(pwd)
+    if [[ $# -gt 0 && "$1" != "--" ]]; then
+        source_dir=$1
+        shift
+    fi
+    build_dir=${source_dir}/build/$(uname -m)-${profile_name}
+    if [[ $# -gt 0 && "$1" != "--" ]]; then
+        build_dir=$1
+        shift
+    fi
+    [[ "$1" == "--" ]] && shift
+
+    cmd=(cmake -S $source_dir -B $build_dir
+         -DCMAKE_C_COMPILER=$cc
+         -DCMAKE_CXX_COMPILER=$cxx
+         -DCMAKE_CXX_STANDARD=$cxx_standard
+         -DCMAKE_BUILD_TYPE=Release
+         -DCMAKE_CXX_FLAGS_RELEASE=-DNDEBUG
+         "-DCMAKE_CXX_FLAGS=$cxx_flags $arch_flags -DMAXREGIONBLOCKSIZE=$region_block_size")
+    if [[ -n "$cuda_arch" ]]; then
+        cmd+=("-DCMAKE_CUDA_FLAGS=$cuda_flags" "-DCUDA_ARCH=$cuda_arch")
+    fi
+    cmd+=("${cmake_options[@]}" -DCMAKE_EXPORT_COMPILE_COMMANDS=On "$@")
+
+    if [[ $run -eq 1 ]]; then
+        "${cmd[@]}"
+    else
+        echo "cmake -S $source_dir -B $build_dir \\"
+        for ((i = 5; i < ${#cmd[@]}; i++)); do
+            a=${cmd[$i]}
+            if [[ "$a" =~ [[:space:]\;,] ]]; then
+                a="${a%%=*}=\"${a#*=}\""
+            fi
+            if [[ $i -lt $((${#cmd[@]} - 1)) ]]; then
+                echo "      $a \\"
+            else
+                echo "      $a"
+            fi
+        done
+    fi
+elif [[ "$mode" == "inp" ]]; then
+    case $io_backend in
+        netcdf) dump_format=nc ;;
+        hdf5) dump_format=hdf5 ;;
+        *) echo "Unknown io_backend $io_backend" >&2; exit 1 ;;
+    esac
+    cat <<EOT
+# Performance settings for $profile_name, generated from
+# $profile_file by bout-profile.sh
+#
+# Run with $ranks_per_node MPI ranks per node and
+#   OMP_NUM_THREADS=$omp_threads OMP_PLACES=cores OMP_PROC_BIND=close
+
+dump_format = $dump_format
+
+[solver]
+type = $solver_type
+
+[laplace]
+type = $laplace_type
+EOT
+else
+    echo "usage: $0 [-p profile] [-r] list|show|cmake|inp" >&2
+    exit 1
+fi
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""Live telemetry for a running BOUT++ simulation.
+
+Publishes per-step timings, solver statistics, memory use and output
+rates in the Prometheus text format. The metrics are read from the
+BOUT.log.<rank> files and output files in the data directory, so the
+simulation itself pays nothing: the exporter runs alongside it, usually
+on the node running rank 0, and only reads what has been appended since
+the last poll. Timings are aggregated across all ranks with logs.
+
+The metrics can be written to a textfile for the node exporter's
+textfile collector, served on a Unix domain socket (each connection
+receives the current metrics and is closed), or both.
+
+usage:
+    bout-telemetry.py [--textfile file] [--socket path] [--interval s]
+                      [--process name] [--once] data_dir
+    bout-telemetry.py --scrape path
+
+--scrape is a minimal scraper, which prints the metrics served on a
+socket, for testing without a Prometheus server.
+"""
+
+import argparse
+import glob
+import os
+import select
+import signal
+import socket
+import sys
+import time
+
+import boutlog
+
+
+def process_rss(name):
+    """Total resident memory in bytes of local processes called name"""
+    total = 0
+    for status in glob.glob("/proc/[0-9]*/status"):
+        try:
+            with open(status) as f:
+                fields = dict(line.split(":", 1) for line in f if ":" in line)
+        except (IOError, OSError):
+            continue
+        if fields.get("Name", "").strip() == name and "VmRSS" in fields:
+            total += int(fields["VmRSS"].split()[0]) * 1024
+    return total
+
+
+class Metrics(object):
+    def __init__(self):
+        self.lines = []
+
+    def add(self, name, kind, description, samples):
+        """Add a metric. samples is a list of (labels dict, value)"""
+        if not samples:
+            return
+        self.lines.append("# HELP {} {}".format(name, description))
+        self.lines.append("# TYPE {} {}".format(name, kind))
+        for labels, value in samples:
+            label_text = ",".join('{}="{}"'.format(k, v) for k, v in sorted(labels.items()))
+            if label_text:
+                label_text = "{" + label_text + "}"
+            value = value if isinstance(value, int) else repr(float(value))
+            self.lines.append("{}{} {}".format(name, label_text, value))
+
+    def text(self):
+        return "\n".join(self.lines) + "\n"
+
+
+def stats(values):
+    """min, mean and max samples for a metric"""
+    return [
+        ({"stat": "min"}, min(values)),
+        ({"stat": "mean"}, sum(values) / len(values)),
+        ({"stat": "max"}, max(values)),
+    ]
+
+
+class Collector(object):
+    def __init__(self, data_dir, process):
+        self.data_dir = data_dir
+        self.process = process
+        self.logs = []
+        self.last_dump = None
+
+    def collect(self):
+        # Pick up ranks whose logs appeared since the last poll
+        known = set(log.path for log in self.logs)
+        self.logs += [log for log in boutlog.rank_logs(self.data_dir) if log.path not in known]
+        for log in self.logs:
+            log.update()
+
+        metrics = Metrics()
+        reporting = [log for log in self.logs if log.steps]
+        metrics.add("bout_ranks_reporting", "gauge", "Ranks with timing lines in their log",
+                    [({}, len(reporting))])
+        if reporting:
+            root = reporting[0]
+            last = root.steps[-1]
+            metrics.add("bout_output_steps_total", "counter", "Output steps completed",
+                        [({}, len(root.steps))])
+            metrics.add("bout_sim_time", "gauge", "Simulation time of the last output",
+                        [({}, last.sim_time)])
+            metrics.add("bout_rhs_evals_total", "counter", "RHS evaluations so far",
+                        [({}, sum(step.rhs_evals for step in root.steps))])
+            metrics.add("bout_step_rhs_evals", "gauge",
+                        "RHS evaluations in the last output step", [({}, last.rhs_evals)])
+
+            # Aggregate each rank's most recent step which all ranks have reached
+            step = min(len(log.steps) for log in reporting) - 1
+            latest = [log.steps[step] for log in reporting]
+            metrics.add("bout_step_wall_seconds", "gauge",
+                        "Wall time of the last output step reached by all ranks",
+                        stats([s.wall for s in latest]))
+            samples = []
+            for phase in boutlog.phases:
+                for labels, value in stats([getattr(s, phase) / 100 for s in latest]):
+                    labels["phase"] = phase
+                    samples.append((labels, value))
+            metrics.add("bout_step_phase_fraction", "gauge",
+                        "Fraction of the step wall time in each phase", samples)
+            metrics.add("bout_step_io_seconds", "gauge", "I/O time in the last output step",
+                        stats([s.wall * s.io / 100 for s in latest]))
+
+        dump_bytes = sum(os.path.getsize(f)
+                         for f in glob.glob(os.path.join(self.data_dir, "BOUT.dmp.*")))
+        now = time.time()
+        metrics.add("bout_dump_bytes", "gauge", "Total size of the output files",
+                    [({}, dump_bytes)])
+        if self.last_dump is not None and now > self.last_dump[0]:
+            rate = max(dump_bytes - self.last_dump[1], 0) / (now - self.last_dump[0])
+            metrics.add("bout_dump_write_bytes_per_second", "gauge",
+                        "Output write rate since the last poll", [({}, rate)])
+        self.last_dump = (now, dump_bytes)
+
+        if self.process:
+            metrics.add("bout_memory_rss_bytes", "gauge",
+                        "Resident memory of the simulation processes on this node",
+                        [({"process": self.process}, process_rss(self.process))])
+
+        metrics.add("bout_telemetry_timestamp_seconds", "gauge", "Time of this poll",
+                    [({}, now)])
+        return metrics.text()
+
+
+def write_textfile(path, text):
+    """Write atomically, so a collector never reads a partial file"""
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        f.write(text)
+    os.rename(tmp, path)
+
+
+def scrape(path):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.connect(path)
+    chunks = []
+    while True:
+        chunk = client.recv(65536)
+        if not chunk:
+            break
+        chunks.append(chunk)
+    client.close()
+    sys.stdout.write(b"".join(chunks).decode())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Live telemetry for a BOUT++ simulation")
+    parser.add_argument("data_dir", nargs="?", help="simulation data directory")
+    parser.add_argument("--textfile", help="Prometheus textfile to write")
+    parser.add_argument("--socket", help="Unix domain socket to serve the metrics on")
+    parser.add_argument("--interval", type=float, default=10.0, help="seconds between polls")
+    parser.add_argument("--process", help="process name to report memory use for")
+    parser.add_argument("--once", action="store_true", help="poll once, print and exit")
+    parser.add_argument("--scrape", metavar="PATH", help="print the metrics served on PATH")
+    args = parser.parse_args()
+
+    if args.scrape:
+        scrape(args.scrape)
+        return 0
+    if args.data_dir is None:
+        parser.error("data_dir is required")
+
+    collector = Collector(args.data_dir, args.process)
+    if args.once:
+        text = collector.collect()
+        if args.textfile:
+            write_textfile(args.textfile, text)
+        else:
+            sys.stdout.write(text)
+        return 0
+    if not args.textfile and not args.socket:
+        parser.error("one of --textfile, --socket or --once is required")
+
+    # Let the finally clause below remove the socket when the job ends
+    signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+
+    server = None
+    if args.socket:
+        if os.path.exists(args.socket):
+            os.unlink(args.socket)
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(args.socket)
+        server.listen(4)
+
+    try:
+        text = collector.collect()
+        next_poll = time.time() + args.interval
+        while True:
+            if args.textfile:
+                write_textfile(args.textfile, text)
+            # Serve the latest poll until the next one is due
+            while True:
+                timeout = next_poll - time.time()
+                if timeout <= 0:
+                    break
+                if server is None:
+                    time.sleep(timeout)
+                    continue
+                ready, _, _ = select.select([server], [], [], timeout)
+                if ready:
+                    connection, _ = server.accept()
+                    try:
+                        connection.sendall(text.encode())
+                    finally:
+                        connection.close()
+            text = collector.collect()
+            next_poll += args.interval
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if server is not None:
+            server.close()
+            os.unlink(args.socket)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
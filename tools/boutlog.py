@@ -0,0 +1,72 @@
+"""Incremental reader for the timing table in BOUT++ log files.
+
+Each output step BOUT++ appends a line to BOUT.log.<rank> such as
+
+    Sim Time  |  RHS evals  | Wall Time |  Calc    Inv   Comm    I/O   SOLVER
+    1.000e+01        127       2.48e-01    75.5    0.0   14.1    1.8    8.7
+
+where Calc, Inv, Comm, I/O and SOLVER are percentages of the wall time
+for that step. A RankLog remembers how far it has read, so polling a log
+only costs the new lines.
+"""
+
+import collections
+import glob
+import os
+import re
+
+Step = collections.namedtuple(
+    "Step", ["sim_time", "rhs_evals", "wall", "calc", "inv", "comm", "io", "solver"]
+)
+
+phases = ["calc", "inv", "comm", "io", "solver"]
+
+_number = r"([-+]?\d*\.?\d+(?:[eE][-+]?\d+)?)"
+_step_line = re.compile(
+    r"^\s*{0}\s+(\d+)\s+{0}\s+{0}\s+{0}\s+{0}\s+{0}\s+{0}(?:\s|$)".format(_number)
+)
+
+
+def parse_step(line):
+    """Return the Step for a timing table line, or None for any other line"""
+    match = _step_line.match(line)
+    if match is None:
+        return None
+    values = match.groups()
+    return Step(
+        float(values[0]), int(values[1]), float(values[2]),
+        *(float(v) for v in values[3:])
+    )
+
+
+class RankLog(object):
+    """Steps read so far from one BOUT.log.<rank> file"""
+
+    def __init__(self, path):
+        self.path = path
+        self.rank = int(path.rsplit(".", 1)[1])
+        self.steps = []
+        self._offset = 0
+        self._partial = ""
+
+    def update(self):
+        """Read any lines appended since the last call, returning the new steps"""
+        try:
+            with open(self.path) as f:
+                f.seek(self._offset)
+                text = f.read()
+                self._offset = f.tell()
+        except (IOError, OSError):
+            return []
+        lines = (self._partial + text).split("\n")
+        self._partial = lines.pop()
+        new = [step for step in map(parse_step, lines) if step is not None]
+        self.steps += new
+        return new
+
+
+def rank_logs(data_dir):
+    """RankLogs for every BOUT.log.<rank> in data_dir, ordered by rank"""
+    logs = [RankLog(path) for path in glob.glob(os.path.join(data_dir, "BOUT.log.*"))
+            if path.rsplit(".", 1)[1].isdigit()]
+    return sorted(logs, key=lambda log: log.rank)
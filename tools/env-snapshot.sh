@@ -0,0 +1,170 @@
+#!/usr/bin/env bash
+# Resolve a setup script into a static environment snapshot, once.
+#
+# The setup scripts purge and load dozens of modules (and on Lassen
+# activate a spack environment), which takes tens of seconds and hits
+# the shared filesystem from every node. This runs the setup script once,
+# records every environment variable, alias and shell function it
+# changes, and writes them to a snapshot file which can be sourced
+# instead. The snapshot is reused until the setup script, a file it
+# sources, or the machine profile changes.
+#
+# Setup scripts may read BOUT_* variables as switches, e.g.
+# BOUT_MPI_ASYNC_PROGRESS in perlmutter/setup-perlmutter.sh. Every
+# BOUT_* variable named in the setup script is part of the snapshot
+# name, so each combination of their values has its own snapshot.
+#
+# usage: env-snapshot.sh [-f] setup_script
+#        env-snapshot.sh [-f] -p profile
+#   -f  resolve the environment again even if a snapshot exists
+#   -p  use the setup_script of a machine profile, e.g. perlmutter
+#
+# The path of the snapshot is printed, so in bash
+#
+#     $ source $(../BOUT-configs/tools/env-snapshot.sh -p perlmutter)
+#
+# and in C shell, with a .csh setup script
+#
+#     > source `../BOUT-configs/tools/env-snapshot.sh ../BOUT-configs/cori/setup-env-cgpu.csh`
+#
+# Snapshots are kept in $BOUT_ENV_SNAPSHOT_DIR (default ~/.cache/bout-env).
+# A snapshot stores absolute values, so it assumes the same login
+# environment as when it was made. Use -f after system module updates.
+configs_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
+snapshot_dir=${BOUT_ENV_SNAPSHOT_DIR:-${HOME}/.cache/bout-env}
+
+force=0
+profile_file=
+while getopts "fp:" opt; do
+    case $opt in
+        f) force=1 ;;
+        p) profile_file=$OPTARG
+           [[ -f "$profile_file" ]] || profile_file=${configs_dir}/profiles/${OPTARG}.sh ;;
+        *) exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [[ -n "$profile_file" ]]; then
+    setup=$(source $profile_file && echo $setup_script)
+    if [[ -z "$setup" ]]; then
+        echo "Profile $profile_file has no setup_script" >&2
+        exit 1
+    fi
+    setup=${configs_dir}/$setup
+elif [[ $# -eq 1 ]]; then
+    setup=$1
+else
+    echo "usage: $0 [-f] setup_script | -p profile" >&2
+    exit 1
+fi
+setup=$(cd "$(dirname "$setup")" && pwd)/$(basename "$setup")
+if [[ ! -f "$setup" ]]; then
+    echo "No setup script $setup" >&2
+    exit 1
+fi
+
+# Key the snapshot on the setup script, any absolute paths it sources
+# (e.g. spack environment loads files) and the profile
+sourced=$(sed -n 's/^[[:space:]]*\(source\|\.\)[[:space:]]\+\(\/[^[:space:]]*\).*/\2/p' "$setup")
+key=$(cat "$setup" $sourced $profile_file 2> /dev/null | cksum | cut -d' ' -f1)
+if [[ "$setup" == *.csh ]]; then
+    shell=csh
+else
+    shell=sh
+fi
+switches=
+for name in $(grep -o 'BOUT_[A-Z0-9_]*' "$setup" | sort -u); do
+    switches+="${name}=${!name}"$'\n'
+done
+switch_key=$(echo -n "$switches" | cksum | cut -d' ' -f1)
+snapshot=${snapshot_dir}/$(basename "$setup" .$shell)-${switch_key}-${key}.$shell
+
+if [[ $force -eq 0 && -f "$snapshot" ]]; then
+    echo "Using environment snapshot $snapshot ($(sed -n 's/^# Resolved in //p' $snapshot) saved)" >&2
+    echo $snapshot
+    exit 0
+fi
+
+echo "Resolving $setup ..." >&2
+mkdir -p $snapshot_dir
+tmp=$(mktemp ${snapshot_dir}/.snapshot.XXXXXX)
+start=$(date +%s.%N)
+
+# Read NUL separated NAME=value pairs into the named associative array
+read_env() {
+    local kv
+    while IFS= read -r -d '' kv; do
+        eval "$1[\${kv%%=*}]=\${kv#*=}"
+    done
+}
+
+# The setup script is run once, saving the resulting environment,
+# aliases and new shell functions to files next to the snapshot
+declare -A before after
+if [[ $shell == csh ]]; then
+    read_env before < <(tcsh -c 'env -0')
+    tcsh -c "alias > $tmp.aliases0; source $setup >& /dev/null; env -0 > $tmp.env; alias > $tmp.aliases"
+    aliases=$(diff $tmp.aliases0 $tmp.aliases | sed -n 's/^> //p')
+else
+    read_env before < <(env -0)
+    bash -c "declare -F > $tmp.functions0
+             source $setup > /dev/null 2>&1
+             env -0 > $tmp.env
+             alias -p > $tmp.aliases
+             for f in \$(declare -F | awk '{print \$3}'); do
+                 grep -q \" \$f\\$\" $tmp.functions0 || declare -f \$f
+             done > $tmp.functions"
+    aliases=$(cat $tmp.aliases)
+    functions=$(cat $tmp.functions)
+fi
+read_env after < $tmp.env
+rm -f $tmp.*
+end=$(date +%s.%N)
+seconds=$(echo "$start $end" | awk '{printf "%.1f s", $2 - $1}')
+
+# Quote a value for csh: single quotes, with ' and ! escaped
+csh_quote() {
+    local v=${1//\'/\'\\\'\'}
+    echo "'${v//!/\\!}'"
+}
+
+{
+    echo "# Environment snapshot of $setup"
+    echo "# Generated by env-snapshot.sh on $(hostname) $(date)"
+    echo "# Resolved in $seconds"
+    echo -n "$switches" | sed 's/^/# with /'
+    for name in "${!after[@]}"; do
+        [[ "$name" =~ ^[A-Za-z_][A-Za-z0-9_]*$ ]] || continue
+        [[ "$name" == "_" || "$name" == "SHLVL" || "$name" == "PWD" ]] && continue
+        value=${after[$name]}
+        [[ -n "${before[$name]+set}" && "${before[$name]}" == "$value" ]] && continue
+        if [[ $shell == csh ]]; then
+            [[ "$value" == *$'\n'* ]] && continue
+            echo "setenv $name $(csh_quote "$value")"
+        else
+            printf 'export %s=%q\n' "$name" "$value"
+        fi
+    done
+    for name in "${!before[@]}"; do
+        [[ "$name" =~ ^[A-Za-z_][A-Za-z0-9_]*$ ]] || continue
+        if [[ -z "${after[$name]+set}" ]]; then
+            [[ $shell == csh ]] && echo "unsetenv $name" || echo "unset $name"
+        fi
+    done
+    if [[ $shell == csh ]]; then
+        echo "$aliases" | while IFS=$'\t' read -r name value; do
+            [[ -z "$name" ]] && continue
+            value=${value#(}
+            echo "alias $name $(csh_quote "${value%)}")"
+        done
+    else
+        echo "$aliases"
+        echo "$functions"
+    fi
+} > $tmp
+rm -f ${snapshot_dir}/$(basename "$setup" .$shell)-${switch_key}-*.$shell
+mv $tmp $snapshot
+
+echo "Resolved in $seconds, wrote $snapshot" >&2
+echo $snapshot
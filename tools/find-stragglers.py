@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Find slow ranks and load imbalance in a BOUT++ run.
+
+For each rank, the RHS (Calc), inversion (Inv) and communication (Comm)
+time per output step is taken from the timing table in BOUT.log.<rank>,
+averaged over the most recent steps. A rank is flagged when one of these
+is both well above the median over ranks (a robust z-score, using the
+median absolute deviation) and more than a minimum fraction above it.
+Flagged ranks are reported with their hostname and position in the
+NXPE x NYPE processor grid.
+
+With --watch the logs are polled periodically while the run continues,
+reading only the lines appended since the last poll. Logs of ranks which
+appear after the start are picked up on the next poll.
+
+Hostnames are not in the BOUT++ logs, so give them with --hosts as the
+output of e.g. `srun -l hostname` (lines of "rank: hostname"), or one
+hostname per line in rank order. NXPE is read from the "Domain split"
+line in BOUT.log.0, or can be given with --nxpe.
+
+usage:
+    find-stragglers.py [--steps n] [--hosts file] [--nxpe n] [--heatmap file]
+                       [--watch s] data_dir
+"""
+
+import argparse
+import os
+import re
+import sys
+import time
+
+import boutlog
+
+timings = ["calc", "inv", "comm"]
+
+
+def read_hosts(path):
+    hosts = {}
+    with open(path) as f:
+        lines = [line.strip() for line in f if line.strip()]
+    for index, line in enumerate(lines):
+        match = re.match(r"^(\d+)\s*:\s*(\S+)", line)
+        if match:
+            hosts[int(match.group(1))] = match.group(2)
+        else:
+            hosts[index] = line.split()[0]
+    return hosts
+
+
+def read_nxpe(data_dir):
+    try:
+        with open(os.path.join(data_dir, "BOUT.log.0")) as f:
+            for line in f:
+                match = re.search(r"NXPE\s*=\s*(\d+)", line)
+                if match:
+                    return int(match.group(1))
+    except (IOError, OSError):
+        pass
+    return None
+
+
+def median(values):
+    ordered = sorted(values)
+    n = len(ordered)
+    return 0.5 * (ordered[(n - 1) // 2] + ordered[n // 2])
+
+
+def rank_times(logs, steps):
+    """Mean seconds per step in each timing over each rank's last steps"""
+    count = min(len(log.steps) for log in logs)
+    window = min(steps, count)
+    result = {}
+    for log in logs:
+        recent = log.steps[count - window:count]
+        result[log.rank] = {
+            name: sum(s.wall * getattr(s, name) / 100 for s in recent) / window
+            for name in timings
+        }
+    return result, count
+
+
+def find_stragglers(times, z_threshold, min_excess):
+    """Return a list of (rank, timing, seconds, median) for flagged ranks"""
+    flagged = []
+    for name in timings:
+        values = [t[name] for t in times.values()]
+        centre = median(values)
+        spread = 1.4826 * median([abs(v - centre) for v in values])
+        for rank, t in sorted(times.items()):
+            excess = t[name] - centre
+            if excess <= min_excess * max(centre, 1e-12):
+                continue
+            if spread > 0 and excess / spread < z_threshold:
+                continue
+            flagged.append((rank, name, t[name], centre))
+    return flagged
+
+
+def write_heatmap(path, times, nxpe, name="calc"):
+    """Write the ratio of each rank's time to the median over the processor grid"""
+    nranks = max(times) + 1
+    nype = (nranks + nxpe - 1) // nxpe
+    centre = median([t[name] for t in times.values()]) or 1.0
+    grid = [[float("nan")] * nxpe for _ in range(nype)]
+    for rank, t in times.items():
+        grid[rank // nxpe][rank % nxpe] = t[name] / centre
+
+    if path.endswith(".png"):
+        try:
+            import matplotlib
+
+            matplotlib.use("Agg")
+            import matplotlib.pyplot as plt
+        except ImportError:
+            sys.exit("matplotlib is needed for a PNG heatmap; use a .csv file instead")
+        fig, ax = plt.subplots()
+        image = ax.imshow(grid, origin="lower", aspect="auto", cmap="RdBu_r",
+                          vmin=0.5, vmax=1.5)
+        ax.set_xlabel("PE_XIND")
+        ax.set_ylabel("PE_YIND")
+        ax.set_title("{} time / median".format(name.capitalize()))
+        fig.colorbar(image)
+        fig.savefig(path)
+    else:
+        with open(path, "w") as f:
+            f.write("# {} time / median, rows PE_YIND 0..{}, columns PE_XIND 0..{}\n".format(
+                name, nype - 1, nxpe - 1))
+            for row in grid:
+                f.write(",".join("{:.4f}".format(v) for v in row) + "\n")
+
+
+def update_logs(logs, data_dir):
+    """Add logs which appeared since the last call, then read new lines.
+
+    Returns True if any log has new steps"""
+    known = set(log.path for log in logs)
+    logs += [log for log in boutlog.rank_logs(data_dir) if log.path not in known]
+    logs.sort(key=lambda log: log.rank)
+    return any([log.update() for log in logs])
+
+
+def report(logs, args, hosts, nxpe):
+    logs = [log for log in logs if log.steps]
+    if len(logs) < 2:
+        print("Need timing lines from at least two ranks")
+        return []
+    times, step = rank_times(logs, args.steps)
+    flagged = find_stragglers(times, args.z, args.min_excess)
+    print("Step {}: {} ranks, {} flagged".format(step, len(times), len(flagged)))
+    for rank, name, seconds, centre in flagged:
+        position = ""
+        if nxpe:
+            position = " (PE_XIND {}, PE_YIND {})".format(rank % nxpe, rank // nxpe)
+        print("  rank {:5d} on {}{}: {} {:.3g} s/step, median {:.3g} s ({:+.0%})".format(
+            rank, hosts.get(rank, "unknown host"), position, name, seconds, centre,
+            seconds / centre - 1 if centre else 0))
+    if args.heatmap:
+        if nxpe:
+            write_heatmap(args.heatmap, times, nxpe)
+        else:
+            print("NXPE unknown, so no heatmap written; use --nxpe")
+    return flagged
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Find slow ranks in a BOUT++ run")
+    parser.add_argument("data_dir", help="simulation data directory")
+    parser.add_argument("--steps", type=int, default=5, help="output steps to average over")
+    parser.add_argument("--z", type=float, default=4.0,
+                        help="robust z-score above the median to flag")
+    parser.add_argument("--min-excess", type=float, default=0.1,
+                        help="minimum fraction above the median to flag")
+    parser.add_argument("--hosts", help="rank to hostname map, e.g. from srun -l hostname")
+    parser.add_argument("--nxpe", type=int, help="NXPE, if not found in BOUT.log.0")
+    parser.add_argument("--heatmap", help="write Calc time / median over the processor"
+                        " grid to this .csv or .png file")
+    parser.add_argument("--watch", type=float, metavar="SECONDS",
+                        help="keep polling the logs at this interval")
+    args = parser.parse_args()
+
+    hosts = read_hosts(args.hosts) if args.hosts else {}
+    nxpe = args.nxpe or read_nxpe(args.data_dir)
+    logs = []
+    update_logs(logs, args.data_dir)
+    if not logs and not args.watch:
+        sys.exit("No BOUT.log.* files in {}".format(args.data_dir))
+
+    flagged = report(logs, args, hosts, nxpe)
+    if not args.watch:
+        return 1 if flagged else 0
+
+    try:
+        while True:
+            time.sleep(args.watch)
+            if update_logs(logs, args.data_dir):
+                report(logs, args, hosts, nxpe)
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,378 @@
+#!/usr/bin/env python3
+"""Local performance regression database for BOUT-dev.
+
+Builds BOUT-dev commits with a machine profile, times the benchmarks
+from run-benchmarks.sh and optionally the Google Benchmark
+microbenchmarks, and stores every sample in a SQLite database keyed by
+commit, profile and host. The report compares each commit with the one before it, and flags
+kernels which got slower both by more than a threshold and significantly
+under Welch's t-test.
+
+Everything runs against a local BOUT-dev checkout: commits are checked
+out in place, submodules are updated from the checkout's own copies, and
+the original HEAD is restored afterwards. With --micro the
+microbenchmarks are run too; if they cannot be built for a commit, for
+example because Google Benchmark is missing or the BOUT++ API differs,
+the example timings are still stored. import adds Google Benchmark
+results from a separate run to a commit's samples, replacing only the
+kernels it imports.
+
+usage:
+    perfdb.py run [-p profile] [-n repeats] [--micro] source_dir commit...
+    perfdb.py import [-p profile] source_dir commit results.json
+    perfdb.py report [-p profile] [--host host] [--alpha a] [--threshold t]
+
+A commit may also be a range such as v5.0.0..next.
+"""
+
+import argparse
+import json
+import math
+import os
+import socket
+import sqlite3
+import subprocess
+import sys
+import tempfile
+import time
+
+tools_dir = os.path.dirname(os.path.abspath(__file__))
+default_db = os.path.join(os.path.expanduser("~"), ".bout-perfdb.sqlite")
+
+schema = """
+CREATE TABLE IF NOT EXISTS runs (
+    id INTEGER PRIMARY KEY,
+    commit_hash TEXT NOT NULL,
+    commit_time INTEGER NOT NULL,
+    profile TEXT NOT NULL,
+    host TEXT NOT NULL,
+    run_time INTEGER NOT NULL,
+    UNIQUE (commit_hash, profile, host)
+);
+CREATE TABLE IF NOT EXISTS samples (
+    run_id INTEGER NOT NULL REFERENCES runs (id) ON DELETE CASCADE,
+    kernel TEXT NOT NULL,
+    seconds REAL NOT NULL
+);
+CREATE INDEX IF NOT EXISTS samples_run ON samples (run_id, kernel);
+"""
+
+
+def connect(path):
+    db = sqlite3.connect(path)
+    db.execute("PRAGMA foreign_keys = ON")
+    db.executescript(schema)
+    return db
+
+
+def git(source_dir, *args):
+    return subprocess.check_output(
+        ["git", "-C", source_dir] + list(args), universal_newlines=True
+    ).strip()
+
+
+def expand_commits(source_dir, specs):
+    """Resolve commits and ranges to full hashes, oldest first"""
+    commits = []
+    for spec in specs:
+        if ".." in spec:
+            commits += git(source_dir, "rev-list", "--reverse", spec).split()
+        else:
+            commits.append(git(source_dir, "rev-parse", spec + "^{commit}"))
+    return commits
+
+
+def default_profile():
+    return os.environ.get(
+        "NERSC_HOST", os.environ.get("LCSCHEDCLUSTER", "linux-" + os.uname().machine)
+    )
+
+
+def read_google_benchmark(path):
+    """Read per-repetition timings from Google Benchmark JSON output.
+
+    Returns a list of (kernel, seconds) samples"""
+    scale = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+    with open(path) as f:
+        results = json.load(f)
+    samples = []
+    for bench in results["benchmarks"]:
+        if bench.get("run_type", "iteration") != "iteration":
+            continue
+        samples.append((bench["name"], bench["real_time"] * scale[bench["time_unit"]]))
+    return samples
+
+
+def run_benchmarks(source_dir, build_dir, profile, repeats, micro):
+    """Configure and build the current checkout, then run the benchmarks
+    and, if micro, the microbenchmarks.
+
+    Returns a list of (kernel, seconds) samples"""
+    subprocess.check_call(
+        [os.path.join(tools_dir, "bout-profile.sh"), "-p", profile, "-r", "cmake",
+         source_dir, build_dir],
+        stdout=subprocess.DEVNULL,
+    )
+    subprocess.check_call(
+        ["cmake", "--build", build_dir, "--parallel", str(os.cpu_count())],
+        stdout=subprocess.DEVNULL,
+    )
+    script = os.path.join(tools_dir, "run-benchmarks.sh")
+    if not micro:
+        output = subprocess.check_output([script, "-n", str(repeats), build_dir],
+                                         universal_newlines=True)
+        return parse_timings(output)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        json_file = os.path.join(tmp, "microbenchmarks.json")
+        try:
+            output = subprocess.check_output(
+                [script, "-n", str(repeats), "-m", json_file, build_dir],
+                universal_newlines=True,
+            )
+            return parse_timings(output) + read_google_benchmark(json_file)
+        except subprocess.CalledProcessError as e:
+            # The examples run before the microbenchmarks, so keep their
+            # timings if they all completed
+            samples = parse_timings(e.output)
+            expected = subprocess.check_output([script, "-l"], universal_newlines=True)
+            if len(samples) != repeats * len(expected.split()):
+                raise
+            print("    microbenchmarks failed, storing the example timings only")
+            return samples
+
+
+def parse_timings(output):
+    """(kernel, seconds) samples from the output of run-benchmarks.sh"""
+    samples = []
+    for line in output.splitlines():
+        kernel, seconds = line.split()
+        samples.append((kernel, float(seconds)))
+    return samples
+
+
+def store(db, commit, commit_time, profile, host, samples):
+    with db:
+        db.execute(
+            "DELETE FROM runs WHERE commit_hash = ? AND profile = ? AND host = ?",
+            (commit, profile, host),
+        )
+        cursor = db.execute(
+            "INSERT INTO runs (commit_hash, commit_time, profile, host, run_time)"
+            " VALUES (?, ?, ?, ?, ?)",
+            (commit, commit_time, profile, host, int(time.time())),
+        )
+        db.executemany(
+            "INSERT INTO samples (run_id, kernel, seconds) VALUES (?, ?, ?)",
+            [(cursor.lastrowid, kernel, seconds) for kernel, seconds in samples],
+        )
+
+
+def cmd_run(args):
+    source_dir = os.path.abspath(args.source_dir)
+    if git(source_dir, "status", "--porcelain", "--untracked-files=no"):
+        sys.exit("error: {} has uncommitted changes".format(source_dir))
+
+    profile = args.profile or default_profile()
+    host = socket.gethostname()
+    build_dir = os.path.join(source_dir, "build", "perfdb-" + profile)
+    db = connect(args.db)
+
+    original = git(source_dir, "rev-parse", "--abbrev-ref", "HEAD")
+    if original == "HEAD":
+        original = git(source_dir, "rev-parse", "HEAD")
+    try:
+        for commit in expand_commits(source_dir, args.commits):
+            print("Benchmarking {} with profile {}".format(commit[:10], profile))
+            git(source_dir, "checkout", "--quiet", commit)
+            git(source_dir, "submodule", "update", "--init", "--recursive", "--no-fetch")
+            commit_time = int(git(source_dir, "log", "-1", "--format=%ct", commit))
+            try:
+                samples = run_benchmarks(source_dir, build_dir, profile, args.repeats,
+                                         args.micro)
+            except subprocess.CalledProcessError as e:
+                print("    failed: {}".format(e))
+                continue
+            store(db, commit, commit_time, profile, host, samples)
+    finally:
+        git(source_dir, "checkout", "--quiet", original)
+        git(source_dir, "submodule", "update", "--init", "--recursive", "--no-fetch")
+
+
+def cmd_import(args):
+    source_dir = os.path.abspath(args.source_dir)
+    commit = git(source_dir, "rev-parse", args.commit + "^{commit}")
+    profile = args.profile or default_profile()
+    host = socket.gethostname()
+    samples = read_google_benchmark(args.json)
+    db = connect(args.db)
+
+    existing = db.execute(
+        "SELECT id FROM runs WHERE commit_hash = ? AND profile = ? AND host = ?",
+        (commit, profile, host),
+    ).fetchone()
+    if existing is None:
+        commit_time = int(git(source_dir, "log", "-1", "--format=%ct", commit))
+        store(db, commit, commit_time, profile, host, samples)
+        return 0
+
+    # Add to the existing run, replacing only the kernels being imported
+    kernels = sorted(set(kernel for kernel, _ in samples))
+    with db:
+        db.executemany(
+            "DELETE FROM samples WHERE run_id = ? AND kernel = ?",
+            [(existing[0], kernel) for kernel in kernels],
+        )
+        db.executemany(
+            "INSERT INTO samples (run_id, kernel, seconds) VALUES (?, ?, ?)",
+            [(existing[0], kernel, seconds) for kernel, seconds in samples],
+        )
+    return 0
+
+
+def betacf(a, b, x):
+    """Continued fraction for the incomplete beta function"""
+    tiny = 1e-300
+    c = 1.0
+    d = 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 200):
+        m2 = 2 * m
+        for aa in (
+            m * (b - m) * x / ((a + m2 - 1.0) * (a + m2)),
+            -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0)),
+        ):
+            d = 1.0 + aa * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + aa / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betai(a, b, x):
+    """Regularized incomplete beta function I_x(a, b)"""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(
+        math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+        + a * math.log(x) + b * math.log(1.0 - x)
+    )
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def mean_var(samples):
+    n = len(samples)
+    mean = sum(samples) / n
+    var = sum((s - mean) ** 2 for s in samples) / (n - 1) if n > 1 else 0.0
+    return mean, var
+
+
+def welch_slower(before, after):
+    """One-sided p-value that `after` has a larger mean than `before`"""
+    if len(before) < 2 or len(after) < 2:
+        return 1.0
+    m1, v1 = mean_var(before)
+    m2, v2 = mean_var(after)
+    se1, se2 = v1 / len(before), v2 / len(after)
+    if se1 + se2 == 0.0:
+        return 0.0 if m2 > m1 else 1.0
+    t = (m2 - m1) / math.sqrt(se1 + se2)
+    dof = (se1 + se2) ** 2 / (se1 ** 2 / (len(before) - 1) + se2 ** 2 / (len(after) - 1))
+    p_two = betai(0.5 * dof, 0.5, dof / (dof + t * t))
+    return 0.5 * p_two if t > 0 else 1.0 - 0.5 * p_two
+
+
+def load_runs(db, profile, host):
+    runs = db.execute(
+        "SELECT id, commit_hash FROM runs WHERE profile = ? AND host = ?"
+        " ORDER BY commit_time, run_time",
+        (profile, host),
+    ).fetchall()
+    result = []
+    for run_id, commit in runs:
+        kernels = {}
+        for kernel, seconds in db.execute(
+            "SELECT kernel, seconds FROM samples WHERE run_id = ?", (run_id,)
+        ):
+            kernels.setdefault(kernel, []).append(seconds)
+        result.append((commit, kernels))
+    return result
+
+
+def cmd_report(args):
+    profile = args.profile or default_profile()
+    host = args.host or socket.gethostname()
+    runs = load_runs(connect(args.db), profile, host)
+    if not runs:
+        sys.exit("No results for profile {} on {}".format(profile, host))
+
+    print("Profile {} on {}: {} commits".format(profile, host, len(runs)))
+    flagged = 0
+    for (old, old_kernels), (new, new_kernels) in zip(runs, runs[1:]):
+        for kernel in sorted(set(old_kernels) & set(new_kernels)):
+            before, after = old_kernels[kernel], new_kernels[kernel]
+            m1, m2 = mean_var(before)[0], mean_var(after)[0]
+            change = m2 / m1 - 1.0
+            p = welch_slower(before, after)
+            if change > args.threshold and p < args.alpha:
+                flagged += 1
+                print(
+                    "  {}..{}  {:30s} {:10.4g} s -> {:10.4g} s  {:+6.1%}  p={:.3g}".format(
+                        old[:10], new[:10], kernel, m1, m2, change, p
+                    )
+                )
+    if flagged == 0:
+        print("  No significant slowdowns")
+    return 1 if flagged else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Local performance regression database for BOUT-dev"
+    )
+    parser.add_argument("--db", default=default_db, help="database file (%(default)s)")
+    sub = parser.add_subparsers(dest="command")
+
+    run = sub.add_parser("run", help="build and benchmark commits")
+    run.add_argument("-p", "--profile", help="machine profile")
+    run.add_argument("-n", "--repeats", type=int, default=5, help="samples per kernel")
+    run.add_argument("--micro", action="store_true",
+                     help="also run the Google Benchmark microbenchmarks")
+    run.add_argument("source_dir", help="local BOUT-dev checkout")
+    run.add_argument("commits", nargs="+", help="commits or ranges to benchmark")
+
+    imp = sub.add_parser("import", help="import Google Benchmark JSON results")
+    imp.add_argument("-p", "--profile", help="machine profile")
+    imp.add_argument("source_dir", help="local BOUT-dev checkout containing the commit")
+    imp.add_argument("commit", help="commit the results are for")
+    imp.add_argument("json", help="Google Benchmark JSON output")
+
+    report = sub.add_parser("report", help="report significant slowdowns")
+    report.add_argument("-p", "--profile", help="machine profile")
+    report.add_argument("--host", help="host (default: this host)")
+    report.add_argument("--alpha", type=float, default=0.01, help="significance level")
+    report.add_argument(
+        "--threshold", type=float, default=0.05, help="minimum relative slowdown"
+    )
+
+    args = parser.parse_args()
+    if args.command == "run":
+        return cmd_run(args)
+    if args.command == "import":
+        return cmd_import(args)
+    if args.command == "report":
+        return cmd_report(args)
+    parser.print_help()
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
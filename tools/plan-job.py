@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""Plan the node count for a BOUT++ run from a fitted performance model.
+
+The model is fitted per machine profile to timings from earlier scaling
+runs, given as CSV with one row per run and columns
+
+    nodes,nx,ny,nz,steps,dumps,wall,comm,io[,memory_gb]
+
+where nx, ny and nz are the grid sizes as in BOUT.inp (nx including the
+x guard cells), steps is the number of output steps, dumps the number of
+output writes, and wall, comm and io are total seconds, which can be
+taken from the Wall Time, Comm and I/O columns in BOUT.log. memory_gb,
+if present, is the peak memory per node.
+
+Per output step the model is
+
+    compute = a * local_cells
+    comm    = alpha + beta * halo_cells
+    io      = delta + gamma * local_cells      (per dump)
+
+where local_cells and halo_cells are per rank for the best NXPE x NYPE
+decomposition. Given a new grid and a per-node memory budget, the
+planner predicts time to solution and parallel efficiency for each node
+count, and recommends the fastest configuration which fits in memory
+and stays above the target efficiency.
+
+usage:
+    plan-job.py -p profile -d runs.csv [--memory-gb m] [--max-nodes n]
+                [--efficiency e] nx ny nz steps [dumps]
+"""
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+
+profiles_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "profiles")
+
+
+def read_profile(name):
+    """Read the settings needed for planning from a machine profile"""
+    path = name if os.path.isfile(name) else os.path.join(profiles_dir, name + ".sh")
+    keys = ["ranks_per_node", "memory_gb"]
+    script = "source {} && echo {}".format(path, " ".join("${%s}" % k for k in keys))
+    values = subprocess.check_output(["bash", "-c", script], universal_newlines=True)
+    return dict(zip(keys, (int(v) for v in values.split())))
+
+
+def decompose(nx, ny, nz, ranks, mxg, myg):
+    """Choose NXPE x NYPE = ranks with the fewest halo cells per rank.
+
+    Returns (nxpe, local_cells, halo_cells), or None if the grid cannot
+    be divided between this many ranks"""
+    nx_interior = nx - 2 * mxg
+    best = None
+    for nxpe in range(1, ranks + 1):
+        if ranks % nxpe or nx_interior % nxpe or ny % (ranks // nxpe):
+            continue
+        local_nx = nx_interior // nxpe
+        local_ny = ny // (ranks // nxpe)
+        if local_nx < mxg or local_ny < myg:
+            continue
+        halo = 2 * (mxg * local_ny + myg * local_nx) * nz
+        if best is None or halo < best[2]:
+            best = (nxpe, local_nx * local_ny * nz, halo)
+    return best
+
+
+def fit_line(xs, ys):
+    """Least squares fit of y = c + m * x, returning (c, m)"""
+    n = len(xs)
+    mean_x = sum(xs) / n
+    mean_y = sum(ys) / n
+    sxx = sum((x - mean_x) ** 2 for x in xs)
+    if sxx == 0.0:
+        return mean_y, 0.0
+    m = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys)) / sxx
+    return mean_y - m * mean_x, m
+
+
+def fit_model(rows, ranks_per_node, mxg, myg):
+    local, halo, compute, comm, io = [], [], [], [], []
+    bytes_per_cell = 0.0
+    for row in rows:
+        nodes = int(row["nodes"])
+        nx, ny, nz = int(row["nx"]), int(row["ny"]), int(row["nz"])
+        steps, dumps = int(row["steps"]), int(row["dumps"])
+        wall, t_comm, t_io = float(row["wall"]), float(row["comm"]), float(row["io"])
+        decomposition = decompose(nx, ny, nz, nodes * ranks_per_node, mxg, myg)
+        if decomposition is None:
+            print("Skipping run which cannot be decomposed: {}".format(row), file=sys.stderr)
+            continue
+        local.append(decomposition[1])
+        halo.append(decomposition[2])
+        compute.append((wall - t_comm - t_io) / steps)
+        comm.append(t_comm / steps)
+        io.append(t_io / max(dumps, 1))
+        if row.get("memory_gb"):
+            cells = (nx - 2 * mxg) * ny * nz
+            bytes_per_cell = max(bytes_per_cell, float(row["memory_gb"]) * 1e9 * nodes / cells)
+    if not local:
+        sys.exit("No usable scaling runs")
+
+    # Compute is proportional to the local cells, so fit through the origin
+    a = sum(c * l for c, l in zip(compute, local)) / sum(l * l for l in local)
+    alpha, beta = fit_line(halo, comm)
+    delta, gamma = fit_line(local, io)
+    return {
+        "a": a,
+        "alpha": max(alpha, 0.0),
+        "beta": max(beta, 0.0),
+        "delta": max(delta, 0.0),
+        "gamma": max(gamma, 0.0),
+        "bytes_per_cell": bytes_per_cell,
+    }
+
+
+def predict(model, local_cells, halo_cells, steps, dumps):
+    compute = model["a"] * local_cells * steps
+    comm = (model["alpha"] + model["beta"] * halo_cells) * steps
+    io = (model["delta"] + model["gamma"] * local_cells) * dumps
+    return compute, comm, io
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Plan the node count for a BOUT++ run from a fitted performance model"
+    )
+    parser.add_argument("-p", "--profile", required=True, help="machine profile")
+    parser.add_argument("-d", "--data", required=True, action="append",
+                        help="CSV of scaling runs on this machine (may be repeated)")
+    parser.add_argument("--memory-gb", type=float,
+                        help="memory budget per node (default: 80%% of the profile's)")
+    parser.add_argument("--bytes-per-cell", type=float,
+                        help="memory per grid cell, if not fitted from the runs")
+    parser.add_argument("--max-nodes", type=int, default=256, help="largest node count")
+    parser.add_argument("--efficiency", type=float, default=0.7,
+                        help="minimum parallel efficiency to recommend")
+    parser.add_argument("--mxg", type=int, default=2, help="x guard cells")
+    parser.add_argument("--myg", type=int, default=2, help="y guard cells")
+    parser.add_argument("nx", type=int)
+    parser.add_argument("ny", type=int)
+    parser.add_argument("nz", type=int)
+    parser.add_argument("steps", type=int, help="number of output steps")
+    parser.add_argument("dumps", type=int, nargs="?", help="number of dumps (default: steps)")
+    args = parser.parse_args()
+
+    profile = read_profile(args.profile)
+    ranks_per_node = profile["ranks_per_node"]
+    memory_gb = args.memory_gb or 0.8 * profile["memory_gb"]
+    dumps = args.steps if args.dumps is None else args.dumps
+
+    rows = []
+    for path in args.data:
+        with open(path) as f:
+            rows += list(csv.DictReader(f))
+    model = fit_model(rows, ranks_per_node, args.mxg, args.myg)
+    bytes_per_cell = args.bytes_per_cell or model["bytes_per_cell"]
+
+    print("Model for {}: compute {:.3g} s/cell, comm {:.3g} s + {:.3g} s/halo cell,"
+          " I/O {:.3g} s + {:.3g} s/cell per dump".format(
+              args.profile, model["a"], model["alpha"], model["beta"],
+              model["delta"], model["gamma"]))
+    if not bytes_per_cell:
+        print("No memory data: memory use is not checked")
+
+    cells = (args.nx - 2 * args.mxg) * args.ny * args.nz
+    print()
+    print("{:>6} {:>6} {:>5} {:>11} {:>9} {:>9} {:>9} {:>7} {:>9}".format(
+        "nodes", "ranks", "NXPE", "time (s)", "compute", "comm", "I/O", "effic.",
+        "mem (GB)"))
+
+    results = []
+    nodes = 1
+    while nodes <= args.max_nodes:
+        decomposition = decompose(args.nx, args.ny, args.nz, nodes * ranks_per_node,
+                                  args.mxg, args.myg)
+        if decomposition is not None:
+            nxpe, local_cells, halo_cells = decomposition
+            parts = predict(model, local_cells, halo_cells, args.steps, dumps)
+            memory = bytes_per_cell * cells / nodes / 1e9
+            results.append((nodes, nxpe, sum(parts), parts, memory))
+        nodes *= 2
+    if not results:
+        sys.exit("The grid cannot be decomposed on up to {} nodes".format(args.max_nodes))
+
+    # Efficiency is relative to the smallest node count which fits in memory
+    fitting = [r for r in results if not bytes_per_cell or r[4] <= memory_gb]
+    reference = fitting[0] if fitting else results[0]
+    recommended = None
+    for nodes, nxpe, total, parts, memory in results:
+        efficiency = reference[2] * reference[0] / (total * nodes)
+        fits = not bytes_per_cell or memory <= memory_gb
+        print("{:>6} {:>6} {:>5} {:>11.4g} {:>9.3g} {:>9.3g} {:>9.3g} {:>6.0%} {:>9.3g}{}".format(
+            nodes, nodes * ranks_per_node, nxpe, total, parts[0], parts[1], parts[2],
+            efficiency, memory, "" if fits else "*"))
+        if fits and efficiency >= args.efficiency:
+            if recommended is None or total < recommended[2]:
+                recommended = (nodes, nxpe, total)
+
+    print()
+    if not fitting:
+        print("* No node count fits in {:.0f} GB per node".format(memory_gb))
+    if recommended is None:
+        print("No configuration reaches {:.0%} efficiency".format(args.efficiency))
+        return 1
+    nodes, nxpe, total = recommended
+    print("Recommended: {} nodes, {} ranks, NXPE = {}, predicted {:.3g} hours".format(
+        nodes, nodes * ranks_per_node, nxpe, total / 3600))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
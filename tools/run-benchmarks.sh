@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+# Build and run a fixed subset of the BOUT++ performance examples in an
+# already configured BOUT-dev build directory. Prints one line
+# "<benchmark> <seconds>" per run on stdout.
+#
+# usage: run-benchmarks.sh [-n repeats] [-t] [-m json] build_dir
+#        run-benchmarks.sh -l
+#   -l  list the benchmarks which would be run, and exit
+#   -n  number of times each benchmark is run (default 3)
+#   -t  build and run the correctness subset with ctest first, and exit
+#       non-zero if any of it fails
+#   -m  also build the Google Benchmark microbenchmarks in ../benchmarks
+#       against build_dir, run them and write their JSON results to json.
+#       Set benchmark_ROOT if Google Benchmark is not found by cmake.
+#
+# The lists can be overridden with BOUT_BENCHMARKS (space separated
+# example names) and BOUT_CHECK_TESTS (ctest names). Set BOUT_MPIRUN to
+# launch the benchmarks under MPI, e.g. BOUT_MPIRUN="srun -n 4".
+benchmarks=${BOUT_BENCHMARKS:-"arithmetic bracket ddx ddy ddz iterator"}
+check_tests=${BOUT_CHECK_TESTS:-"serial_tests test-delp2 test-interpolate test-invpar test-cyclic"}
+jobs=${BOUT_BUILD_JOBS:-$(nproc)}
+configs_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
+
+repeats=3
+check=0
+json=
+while getopts "n:tm:l" opt; do
+    case $opt in
+        l) echo $benchmarks; exit 0 ;;
+        n) repeats=$OPTARG ;;
+        t) check=1 ;;
+        m) json=$(cd "$(dirname "$OPTARG")" && pwd)/$(basename "$OPTARG") ;;
+        *) exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [[ $# -ne 1 ]]; then
+    echo "usage: $0 [-n repeats] [-t] [-m json] build_dir | -l" >&2
+    exit 1
+fi
+build_dir=$(cd "$1" && pwd) || exit 1
+
+if [[ $check -eq 1 ]]; then
+    cmake -DBOUT_TESTS=On $build_dir > /dev/null || exit 1
+    for t in $check_tests; do
+        cmake --build $build_dir --parallel $jobs --target $t > /dev/null || exit 1
+    done
+    regex="^($(echo $check_tests | tr ' ' '|'))\$"
+    (cd $build_dir && ctest -R "$regex" --output-on-failure) >&2 || exit 1
+fi
+
+cmake -DBOUT_BUILD_EXAMPLES=On $build_dir > /dev/null || exit 1
+for b in $benchmarks; do
+    cmake --build $build_dir --parallel $jobs --target $b > /dev/null || exit 1
+done
+
+for b in $benchmarks; do
+    dir=${build_dir}/examples/performance/$b
+    for ((i = 0; i < repeats; i++)); do
+        start=$(date +%s.%N)
+        (cd $dir && $BOUT_MPIRUN ./$b -q -q > /dev/null) || exit 1
+        end=$(date +%s.%N)
+        echo "$b $(echo "$start $end" | awk '{printf "%.6f", $2 - $1}')"
+    done
+done
+
+if [[ -n "$json" ]]; then
+    bench_dir=${build_dir}/bout-benchmarks
+    cmake -S ${configs_dir}/benchmarks -B $bench_dir \
+          -DCMAKE_BUILD_TYPE=Release \
+          -Dbout++_DIR=$build_dir > /dev/null || exit 1
+    cmake --build $bench_dir --parallel $jobs > /dev/null || exit 1
+    (cd $bench_dir && $BOUT_MPIRUN ./bout-benchmarks -q -q \
+         --benchmark_repetitions=$repeats \
+         --benchmark_out_format=json \
+         --benchmark_out=$json > /dev/null) || exit 1
+fi